@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+#
+# joytest.py - exercises the joystick handler of missile_launcher via uinput
+#
+# Creates a virtual gamepad, plays stick, d-pad and trigger events and checks
+# the left/right/up/down/fire files of the attached launcher after each step.
+#
+# usage: sudo ./joytest.py [--fire]
+#   1) sudo modprobe uinput
+#   2) sudo ./joytest.py            (the pad is created, the script waits)
+#   3) sudo insmod missile_launcher.ko joystick=ml-joytest   (in a second shell)
+#
+# The trigger is only pressed with --fire, as it really fires a missile.
+#
+# Copyright (C) 2026  agent <agent@local>
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+import fcntl
+import glob
+import os
+import struct
+import sys
+import time
+
+NAME = b"ml-joytest"
+SYSFS = "/sys/bus/usb/drivers/missilelauncher/*/left"
+
+EV_SYN, EV_KEY, EV_ABS = 0x00, 0x01, 0x03
+SYN_REPORT = 0x00
+ABS_X, ABS_Y, ABS_HAT0X, ABS_HAT0Y = 0x00, 0x01, 0x10, 0x11
+BTN_TRIGGER, BTN_A = 0x120, 0x130
+BUS_VIRTUAL = 0x06
+ABS_CNT = 64
+
+UI_DEV_CREATE = 0x5501
+UI_DEV_DESTROY = 0x5502
+UI_SET_EVBIT = 0x40045564
+UI_SET_KEYBIT = 0x40045565
+UI_SET_ABSBIT = 0x40045567
+
+# stick range 0..255 centred at 127, the default deadzone of 25% is 32 units
+AXES = {ABS_X: (0, 255), ABS_Y: (0, 255), ABS_HAT0X: (-1, 1), ABS_HAT0Y: (-1, 1)}
+CENTER = {ABS_X: 127, ABS_Y: 127, ABS_HAT0X: 0, ABS_HAT0Y: 0}
+
+
+def create_pad():
+    fd = os.open("/dev/uinput", os.O_WRONLY | os.O_NONBLOCK)
+    for ev in (EV_SYN, EV_KEY, EV_ABS):
+        fcntl.ioctl(fd, UI_SET_EVBIT, ev)
+    for key in (BTN_TRIGGER, BTN_A):
+        fcntl.ioctl(fd, UI_SET_KEYBIT, key)
+    absmax = [0] * ABS_CNT
+    absmin = [0] * ABS_CNT
+    for code, (lo, hi) in AXES.items():
+        fcntl.ioctl(fd, UI_SET_ABSBIT, code)
+        absmin[code] = lo
+        absmax[code] = hi
+    # struct uinput_user_dev
+    dev = struct.pack("80sHHHHI", NAME, BUS_VIRTUAL, 0x1, 0x1, 1, 0)
+    dev += struct.pack("%di" % ABS_CNT, *absmax)
+    dev += struct.pack("%di" % ABS_CNT, *absmin)
+    dev += struct.pack("%di" % (2 * ABS_CNT), *([0] * 2 * ABS_CNT))
+    os.write(fd, dev)
+    fcntl.ioctl(fd, UI_DEV_CREATE)
+    return fd
+
+
+def emit(fd, events):
+    now = time.time()
+    sec, usec = int(now), int((now % 1) * 1000000)
+    for ev_type, code, value in list(events) + [(EV_SYN, SYN_REPORT, 0)]:
+        os.write(fd, struct.pack("llHHi", sec, usec, ev_type, code, value))
+
+
+def launcher_dir():
+    while True:
+        found = glob.glob(SYSFS)
+        if found:
+            return os.path.dirname(found[0])
+        time.sleep(0.5)
+
+
+def state(path):
+    result = {}
+    for name in ("left", "right", "up", "down", "fire"):
+        with open(os.path.join(path, name)) as f:
+            result[name] = int(f.read())
+    return result
+
+
+def check(fd, path, label, reports, expected):
+    for events in reports:
+        emit(fd, events)
+        time.sleep(0.3)
+    want = dict.fromkeys(("left", "right", "up", "down", "fire"), 0)
+    want.update(dict.fromkeys(expected, 1))
+    got = state(path)
+    ok = got == want
+    print("%-4s %-32s %s" % ("ok" if ok else "FAIL", label,
+                             " ".join(k for k, v in sorted(got.items()) if v) or "-"))
+    emit(fd, [(EV_ABS, code, CENTER[code]) for code in AXES] + [(EV_KEY, BTN_TRIGGER, 0)])
+    time.sleep(0.3)
+    return ok
+
+
+def main():
+    fire = "--fire" in sys.argv[1:]
+    fd = create_pad()
+    print("created input device %s, waiting for the launcher..." % NAME.decode())
+    path = launcher_dir()
+    time.sleep(1)
+
+    # each step is a list of reports, the state is checked after the last one
+    steps = [
+        ("stick left", [[(EV_ABS, ABS_X, 0)]], ["left"]),
+        ("stick right", [[(EV_ABS, ABS_X, 255)]], ["right"]),
+        ("stick up", [[(EV_ABS, ABS_Y, 0)]], ["up"]),
+        ("stick down", [[(EV_ABS, ABS_Y, 255)]], ["down"]),
+        ("stick up-left, one report", [[(EV_ABS, ABS_X, 0), (EV_ABS, ABS_Y, 0)]], ["left", "up"]),
+        ("stick inside deadzone", [[(EV_ABS, ABS_X, 150), (EV_ABS, ABS_Y, 100)]], []),
+        ("stick outside deadzone", [[(EV_ABS, ABS_X, 170)]], ["right"]),
+        ("d-pad left", [[(EV_ABS, ABS_HAT0X, -1)]], ["left"]),
+        ("d-pad right", [[(EV_ABS, ABS_HAT0X, 1)]], ["right"]),
+        ("d-pad up", [[(EV_ABS, ABS_HAT0Y, -1)]], ["up"]),
+        ("d-pad down", [[(EV_ABS, ABS_HAT0Y, 1)]], ["down"]),
+        ("d-pad right over stick left", [[(EV_ABS, ABS_X, 0)], [(EV_ABS, ABS_HAT0X, 1)]], ["right"]),
+        ("stick held, d-pad released",
+         [[(EV_ABS, ABS_X, 0)], [(EV_ABS, ABS_HAT0X, -1)], [(EV_ABS, ABS_HAT0X, 0)]], ["left"]),
+        ("d-pad held, stick in deadzone",
+         [[(EV_ABS, ABS_HAT0Y, -1)], [(EV_ABS, ABS_Y, 140)], [(EV_ABS, ABS_Y, 120)]], ["up"]),
+    ]
+    if fire:
+        steps.append(("trigger", [[(EV_KEY, BTN_TRIGGER, 1)]], ["fire"]))
+
+    failed = 0
+    try:
+        for label, reports, expected in steps:
+            if not check(fd, path, label, reports, expected):
+                failed += 1
+    finally:
+        fcntl.ioctl(fd, UI_DEV_DESTROY)
+        os.close(fd)
+
+    print("%d of %d checks failed" % (failed, len(steps)))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
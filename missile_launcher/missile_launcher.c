@@ -28,6 +28,14 @@
 #include <linux/module.h>
 #include <linux/usb.h>
 #include <linux/delay.h>
+#include <linux/input.h>
+#include <linux/workqueue.h>
+#include <linux/spinlock.h>
+#include <linux/moduleparam.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 
 #define VENDOR_ID 0x0416
 #define PRODUCT_ID 0x9391
@@ -39,6 +47,43 @@
 #define FIRE 0x10
 #define STOP 0x0 
 
+/* default timing of a fire sequence in milliseconds */
+#define FIRE_INTERVAL 4000
+#define FIRE_HOLD 3000
+
+/* no valid command mask, forces the joystick work to resend its state */
+#define JOY_INVALID 0xff
+
+/* name of the input device used to aim the launcher, unset disables the joystick handler */
+static char *joystick;
+module_param(joystick, charp, 0444);
+MODULE_PARM_DESC(joystick, "Name of the input device (joystick/gamepad) controlling the launcher");
+
+/* axis deflection in percent of the half range needed to start a movement */
+static int joystick_deadzone = 25;
+
+/**
+* @brief Setter of the "joystick_deadzone" parameter, accepts only 0 to 99 percent
+* @return Returns 0 on success, -EINVAL on invalid input
+*/
+static int launcher_set_deadzone(const char *val, const struct kernel_param *kp){
+
+    int deadzone;
+
+    if (kstrtoint(val, 10, &deadzone) || deadzone < 0 || deadzone > 99){
+        return -EINVAL;
+    }
+    *(int *)kp->arg = deadzone;
+    return 0;
+}
+
+static const struct kernel_param_ops deadzone_ops = {
+	.set =	launcher_set_deadzone,
+	.get =	param_get_int,
+};
+module_param_cb(joystick_deadzone, &deadzone_ops, &joystick_deadzone, 0644);
+MODULE_PARM_DESC(joystick_deadzone, "Axis deadzone in percent, 0-99 (default 25)");
+
 
 /* table of devices that work with this driver */
 static struct usb_device_id id_table [] = {
@@ -49,16 +94,291 @@ MODULE_DEVICE_TABLE (usb, id_table);
 
 struct usb_launcher {
 	struct usb_device	*udev;
+	struct usb_interface	*interface;
 	unsigned char left;
 	unsigned char right;
 	unsigned char up;
 	unsigned char down;
 	unsigned char fire;
 	unsigned char stop;
+	
+	/* serializes the transfers of the joystick and the fire sequence */
+	struct mutex send_lock;
+	
+	/* joystick state, joy_mask is protected by joy_lock, joy_sent by send_lock */
+	unsigned char joy_mask;
+	unsigned char joy_sent;
+	struct work_struct joy_work;
+	struct list_head list;
+	
+	/* fire sequence state, protected by fire_lock */
+	struct delayed_work fire_work;
+	spinlock_t fire_lock;
+	unsigned int fire_interval;
+	unsigned int fire_hold;
+	unsigned int seq_interval;
+	unsigned int seq_hold;
+	unsigned int fire_requested;
+	unsigned int fire_done;
+	int fire_running;
+	int fire_on;
+	const char *fire_result;
+	ktime_t fire_start;
+	ktime_t fire_shot;
+	unsigned int fire_elapsed;
+	unsigned int cycle_last;
+	unsigned int cycle_min;
+	unsigned int cycle_max;
+	unsigned int cycle_count;
+	unsigned int cycle_total;
 };
 
 static struct usb_launcher* launcher = {0};
 
+/* attached launchers and the one driven by the joystick handler, protected by joy_lock */
+static LIST_HEAD(launchers);
+static struct usb_launcher* joy_launcher = NULL;
+static DEFINE_SPINLOCK(joy_lock);
+
+/* direction (-1, 0, 1) or button state of every joystick control, protected by joy_lock */
+static struct {
+	int x_stick;
+	int x_hat;
+	int y_stick;
+	int y_hat;
+	int trigger;
+	int a;
+} joy_state;
+
+/**
+* @brief Sends a command mask (LEFT, RIGHT, UP, DOWN, FIRE or STOP) to the device
+* @return Returns the value given by usb_control_msg()
+*/
+static int launcher_send(struct usb_launcher *dev, unsigned char cmd){
+
+    int retval;
+    unsigned char *packet;
+
+    /* transfer buffers have to be DMA capable, so no stack memory here */
+    packet = kmalloc(5, GFP_KERNEL);
+    if (packet == NULL){
+        return -ENOMEM;
+    }
+    packet[0] = 0x5f;
+    packet[1] = cmd;
+    packet[2] = 0xe0;
+    packet[3] = 0xff;
+    packet[4] = 0xfe;
+
+    retval = usb_control_msg(
+                dev->udev,
+                    usb_sndctrlpipe(dev->udev, 0),
+                        0x09,
+                            0x21,
+                                0x0300,
+                                    0x00,
+                                        packet,
+                                            5,
+                                                2000
+             );
+
+    if(retval < 0){
+        pr_alert("error while ctrl transfer");
+    }
+
+    kfree(packet);
+    return retval;
+}
+
+/**
+* @brief Signals the end of a fire sequence via poll() on "fire_sequence" and an uevent
+* carrying the result ("done", "aborted" or "error")
+*/
+static void launcher_fire_notify(struct usb_launcher *dev, const char *result){
+
+    char env[32];
+    char *envp[] = { env, NULL };
+
+    snprintf(env, sizeof(env), "FIRE_SEQUENCE=%s", result);
+    sysfs_notify(&dev->interface->dev.kobj, NULL, "fire_sequence");
+    kobject_uevent_env(&dev->interface->dev.kobj, KOBJ_CHANGE, envp);
+}
+
+/**
+* @brief Checks if a fire sequence is running
+* @return Returns 1 if a sequence is running, 0 otherwise
+*/
+static int launcher_fire_busy(struct usb_launcher *dev){
+
+    unsigned long flags;
+    int running;
+
+    spin_lock_irqsave(&dev->fire_lock, flags);
+    running = dev->fire_running;
+    spin_unlock_irqrestore(&dev->fire_lock, flags);
+
+    return running;
+}
+
+/**
+* @brief Sends a command of the fire sequence. The joystick state is invalidated,
+* so the joystick work resends it once the sequence is over.
+* @return Returns the value given by launcher_send()
+*/
+static int launcher_fire_send(struct usb_launcher *dev, unsigned char cmd){
+
+    int retval;
+
+    mutex_lock(&dev->send_lock);
+    retval = launcher_send(dev, cmd);
+    dev->joy_sent = JOY_INVALID;
+    mutex_unlock(&dev->send_lock);
+
+    return retval;
+}
+
+/**
+* @brief Hands the device back to the joystick after a command sent by launcher_fire_send(),
+* the joystick work resends the current state if the launcher is driven by the joystick
+*/
+static void launcher_joy_resume(struct usb_launcher *dev){
+
+    unsigned long flags;
+
+    spin_lock_irqsave(&joy_lock, flags);
+    if (joy_launcher == dev){
+        schedule_work(&dev->joy_work);
+    }
+    spin_unlock_irqrestore(&joy_lock, flags);
+}
+
+/**
+* @brief Ends a fire sequence from the work function and hands the device back to the joystick
+*/
+static void launcher_fire_end(struct usb_launcher *dev, const char *result, ktime_t now){
+
+    unsigned long flags;
+
+    spin_lock_irqsave(&dev->fire_lock, flags);
+    if (dev->fire_done > 0 || dev->fire_on){
+        dev->fire_elapsed = ktime_to_ms(ktime_sub(now, dev->fire_start));
+    }
+    dev->fire_running = 0;
+    dev->fire_on = 0;
+    dev->fire_result = result;
+    spin_unlock_irqrestore(&dev->fire_lock, flags);
+
+    launcher_fire_notify(dev, result);
+    launcher_joy_resume(dev);
+}
+
+/**
+* @brief Work function stepping through a fire sequence.
+* Each shot latches FIRE for seq_hold ms, shots start every seq_interval ms
+* counted from the start of the sequence, so transfer delays do not add up.
+* A failed transfer ends the sequence with the result "error", the shot is not counted.
+* A failed STOP is retried once; if it fails again, "fire" stays 1 as the device may
+* still be firing.
+*/
+static void launcher_fire_work(struct work_struct *work){
+
+    struct usb_launcher *dev = container_of(work, struct usb_launcher, fire_work.work);
+    unsigned long flags;
+    unsigned int cycle;
+    s64 delay;
+    ktime_t now;
+
+    if (!launcher_fire_busy(dev)){
+        return;
+    }
+
+    if (!dev->fire_on){
+        if (launcher_fire_send(dev, FIRE) < 0){
+            launcher_fire_end(dev, "error", ktime_get());
+            return;
+        }
+        now = ktime_get();
+
+        spin_lock_irqsave(&dev->fire_lock, flags);
+        if (dev->fire_done > 0){
+            cycle = ktime_to_ms(ktime_sub(now, dev->fire_shot));
+            dev->cycle_last = cycle;
+            if (dev->cycle_count == 0 || cycle < dev->cycle_min){
+                dev->cycle_min = cycle;
+            }
+            if (cycle > dev->cycle_max){
+                dev->cycle_max = cycle;
+            }
+            dev->cycle_count++;
+            dev->cycle_total += cycle;
+        } else {
+            dev->fire_start = now;
+        }
+        dev->fire_shot = now;
+        dev->fire_on = 1;
+        spin_unlock_irqrestore(&dev->fire_lock, flags);
+
+        dev->fire = 1;
+        schedule_delayed_work(&dev->fire_work, msecs_to_jiffies(dev->seq_hold));
+        return;
+    }
+
+    /* FIRE stays latched if the STOP is lost, so try it a second time */
+    if (launcher_fire_send(dev, STOP) < 0 && launcher_fire_send(dev, STOP) < 0){
+        launcher_fire_end(dev, "error", ktime_get());
+        return;
+    }
+    now = ktime_get();
+    dev->fire = 0;
+
+    spin_lock_irqsave(&dev->fire_lock, flags);
+    dev->fire_on = 0;
+    dev->fire_done++;
+    dev->fire_elapsed = ktime_to_ms(ktime_sub(now, dev->fire_start));
+    if (dev->fire_done >= dev->fire_requested){
+        spin_unlock_irqrestore(&dev->fire_lock, flags);
+        launcher_fire_end(dev, "done", now);
+        return;
+    }
+    spin_unlock_irqrestore(&dev->fire_lock, flags);
+
+    delay = (s64)dev->fire_done * dev->seq_interval - dev->fire_elapsed;
+    if (delay < 0){
+        delay = 0;
+    }
+    schedule_delayed_work(&dev->fire_work, msecs_to_jiffies((unsigned int)delay));
+}
+
+/**
+* @brief Aborts a running fire sequence. The caller has to send STOP to the device via
+* launcher_fire_send() and then call launcher_joy_resume().
+* @return Returns 1 if a sequence was running, 0 otherwise
+*/
+static int launcher_fire_abort(struct usb_launcher *dev){
+
+    unsigned long flags;
+    int running;
+
+    cancel_delayed_work_sync(&dev->fire_work);
+
+    spin_lock_irqsave(&dev->fire_lock, flags);
+    running = dev->fire_running;
+    if (running){
+        dev->fire_running = 0;
+        dev->fire_result = "aborted";
+        if (dev->fire_done > 0 || dev->fire_on){
+            dev->fire_elapsed = ktime_to_ms(ktime_sub(ktime_get(), dev->fire_start));
+        }
+        dev->fire_on = 0;
+    }
+    spin_unlock_irqrestore(&dev->fire_lock, flags);
+
+    if (running){
+        launcher_fire_notify(dev, "aborted");
+    }
+    return running;
+}
+
 /**
 * @brief Invoked function if the "left-file" is read
 * @return Returns the current value of the "left-file"
@@ -75,7 +395,7 @@ static ssize_t show_left(struct device *dev, struct device_attribute *attr, char
 
 /**
 * @brief Invoked function if something is stored in "left-file"
-* @return Returns the number of bytes stored.
+* @return Returns the number of bytes stored, -EBUSY while a fire sequence runs.
 */
 static ssize_t store_left(struct device *dev, struct device_attribute *attr,
 			 const char *buf, size_t count){
@@ -88,6 +408,11 @@ static ssize_t store_left(struct device *dev, struct device_attribute *attr,
     intf = to_usb_interface(dev);                       
     launcher = usb_get_intfdata(intf);
     
+    /* a direction would be cut off by the next command of the sequence */
+    if (launcher_fire_busy(launcher)){
+        return -EBUSY;
+    }
+    
 	if (sysfs_streq(buf, "0")){
 	
 		launcher->left = 0;
@@ -161,7 +486,7 @@ static ssize_t show_right(struct device *dev, struct device_attribute *attr, cha
 
 /**
 * @brief Invoked function if something is stored in "right-file"
-* @return Returns the number of bytes stored.
+* @return Returns the number of bytes stored, -EBUSY while a fire sequence runs.
 */
 static ssize_t store_right(struct device *dev, struct device_attribute *attr,
 			 const char *buf, size_t count){
@@ -174,6 +499,11 @@ static ssize_t store_right(struct device *dev, struct device_attribute *attr,
     intf = to_usb_interface(dev);                       
     launcher = usb_get_intfdata(intf);
     
+    /* a direction would be cut off by the next command of the sequence */
+    if (launcher_fire_busy(launcher)){
+        return -EBUSY;
+    }
+    
 	if (sysfs_streq(buf, "0")){
 	
 		launcher->right = 0;
@@ -246,7 +576,7 @@ static ssize_t show_up(struct device *dev, struct device_attribute *attr, char *
 
 /**
 * @brief Invoked function if something is stored in "up-file"
-* @return Returns the number of bytes stored.
+* @return Returns the number of bytes stored, -EBUSY while a fire sequence runs.
 */
 static ssize_t store_up(struct device *dev, struct device_attribute *attr,
 			 const char *buf, size_t count){
@@ -259,6 +589,11 @@ static ssize_t store_up(struct device *dev, struct device_attribute *attr,
     intf = to_usb_interface(dev);                       
     launcher = usb_get_intfdata(intf);
     
+    /* a direction would be cut off by the next command of the sequence */
+    if (launcher_fire_busy(launcher)){
+        return -EBUSY;
+    }
+    
 	if (sysfs_streq(buf, "0")){
 	
 		launcher->up = 0;
@@ -333,7 +668,7 @@ static ssize_t show_down(struct device *dev, struct device_attribute *attr,	char
 
 /**
 * @brief Invoked function if something is stored in "down-file"
-* @return Returns the number of bytes stored.
+* @return Returns the number of bytes stored, -EBUSY while a fire sequence runs.
 */
 static ssize_t store_down(struct device *dev, struct device_attribute *attr,
 			 const char *buf, size_t count){
@@ -346,6 +681,11 @@ static ssize_t store_down(struct device *dev, struct device_attribute *attr,
     intf = to_usb_interface(dev);                       
     launcher = usb_get_intfdata(intf);
     
+    /* a direction would be cut off by the next command of the sequence */
+    if (launcher_fire_busy(launcher)){
+        return -EBUSY;
+    }
+    
 	if (sysfs_streq(buf, "0")){
 	 
 		launcher->down = 0;
@@ -419,7 +759,7 @@ static ssize_t show_fire(struct device *dev, struct device_attribute *attr, char
 
 /**
 * @brief Invoked function if something is stored in "fire-file"
-* @return Returns the number of bytes stored.
+* @return Returns the number of bytes stored, -EBUSY on "1" while a fire sequence runs.
 */
 static ssize_t store_fire(struct device *dev, struct device_attribute *attr,
 			 const char *buf, size_t count){
@@ -428,33 +768,23 @@ static ssize_t store_fire(struct device *dev, struct device_attribute *attr,
     struct usb_interface* intf;
     
     unsigned char direction[] = {0x5f, FIRE, 0xe0, 0xff, 0xfe};
-    unsigned char stop[] = {0x5f, STOP, 0xe0, 0xff, 0xfe};
     intf = to_usb_interface(dev);                       
     launcher = usb_get_intfdata(intf);
     
 	if (sysfs_streq(buf, "0")){
 	
+		launcher_fire_abort(launcher);
 		launcher->fire = 0;
 		
-		retval = usb_control_msg(
-		            launcher->udev,
-                        usb_sndctrlpipe(launcher->udev, 0),
-                            0x09,
-                                0x21,
-                                    0x0300,
-                                        0x00,
-                                            stop,
-                                                sizeof(stop),
-                                                    2000
-                 );
-                 
-        if(retval < 0){
-            pr_alert("error while ctrl transfer");
-        } 
+		launcher_fire_send(launcher, STOP);
+		launcher_joy_resume(launcher);
 	}
 		
 	if (sysfs_streq(buf, "1")){
 	
+	    if (launcher_fire_busy(launcher)){
+	        return -EBUSY;
+	    }
 	    launcher->fire = 1;
 	    
 		/*int usb_control_msg(
@@ -510,10 +840,8 @@ static ssize_t show_stop(struct device *dev, struct device_attribute *attr, char
 static ssize_t store_stop(struct device *dev, struct device_attribute *attr,
 			 const char *buf, size_t count){
 			 
-    int retval;
     struct usb_interface* intf;
     
-    unsigned char stop[] = {0x5f, STOP, 0xe0, 0xff, 0xfe};
     intf = to_usb_interface(dev);                       
     launcher = usb_get_intfdata(intf);
     
@@ -525,40 +853,234 @@ static ssize_t store_stop(struct device *dev, struct device_attribute *attr,
 		
 	if (sysfs_streq(buf, "1")){
 	
+	    launcher_fire_abort(launcher);
 	    launcher->stop = 1;
 	    
-		/*int usb_control_msg(
-		        struct usb_device *dev, 
-		            unsigned int pipe,
-                        _ _u8 request, 
-                            _ _u8 requesttype,
-                                _ _u16 value, 
-                                    _ _u16 index,
-                                        void *data, 
-                                            _ _u16 size, 
-                                            int timeout);*/
-	     
-        retval = usb_control_msg(
-	                launcher->udev,
-                        usb_sndctrlpipe(launcher->udev, 0),
-                            0x09,
-                                0x21,
-                                    0x0300,
-                                        0x00,
-                                            stop,
-                                                sizeof(stop),
-                                                    2000
-                    );
-	  
-        if(retval < 0){
-            pr_alert("error while ctrl transfer");
-        }
-         
+	    launcher_fire_send(launcher, STOP);
+	    launcher_joy_resume(launcher);
 	}
 	
     return count;
 }
 
+/**
+* @brief Invoked function if the "fire_sequence-file" is read
+* @return Returns the number of shots still to be fired
+*/
+static ssize_t show_fire_sequence(struct device *dev, struct device_attribute *attr, char *buf){
+
+    struct usb_interface *intf;
+    unsigned int remaining = 0;
+    unsigned long flags;
+    
+    intf = to_usb_interface(dev);
+    launcher = usb_get_intfdata(intf);
+    
+    spin_lock_irqsave(&launcher->fire_lock, flags);
+    if (launcher->fire_running){
+        remaining = launcher->fire_requested - launcher->fire_done;
+    }
+    spin_unlock_irqrestore(&launcher->fire_lock, flags);
+    
+    return sprintf(buf, "%u\n", remaining);
+}
+
+/**
+* @brief Invoked function if something is stored in "fire_sequence-file".
+* Writing N starts a sequence of N shots, writing 0 aborts a running sequence.
+* @return Returns the number of bytes stored, -EINVAL on invalid input, -EBUSY
+* if a sequence is already running or FIRE is latched.
+*/
+static ssize_t store_fire_sequence(struct device *dev, struct device_attribute *attr,
+			 const char *buf, size_t count){
+			 
+    struct usb_interface* intf;
+    unsigned int shots;
+    unsigned long flags;
+    
+    intf = to_usb_interface(dev);                       
+    launcher = usb_get_intfdata(intf);
+    
+    if (kstrtouint(buf, 10, &shots)){
+        return -EINVAL;
+    }
+    
+    if (shots == 0){
+        if (launcher_fire_abort(launcher)){
+            if (launcher_fire_send(launcher, STOP) >= 0){
+                launcher->fire = 0;
+            }
+            launcher_joy_resume(launcher);
+        }
+        return count;
+    }
+    
+    /*
+     * FIRE latched by "fire" or the joystick would leave the first shot without a
+     * defined start. send_lock keeps the joystick from latching it meanwhile.
+     */
+    mutex_lock(&launcher->send_lock);
+    spin_lock_irqsave(&launcher->fire_lock, flags);
+    if (launcher->fire_running || launcher->fire){
+        spin_unlock_irqrestore(&launcher->fire_lock, flags);
+        mutex_unlock(&launcher->send_lock);
+        return -EBUSY;
+    }
+    launcher->fire_running = 1;
+    launcher->fire_on = 0;
+    launcher->seq_interval = launcher->fire_interval;
+    launcher->seq_hold = launcher->fire_hold;
+    launcher->fire_requested = shots;
+    launcher->fire_done = 0;
+    launcher->fire_elapsed = 0;
+    launcher->cycle_last = 0;
+    launcher->cycle_min = 0;
+    launcher->cycle_max = 0;
+    launcher->cycle_count = 0;
+    launcher->cycle_total = 0;
+    spin_unlock_irqrestore(&launcher->fire_lock, flags);
+    mutex_unlock(&launcher->send_lock);
+    
+    schedule_delayed_work(&launcher->fire_work, 0);
+    
+    return count;
+}
+
+/**
+* @brief Invoked function if the "fire_interval-file" is read
+* @return Returns the time between two shot starts in milliseconds
+*/
+static ssize_t show_fire_interval(struct device *dev, struct device_attribute *attr, char *buf){
+
+    struct usb_interface *intf;
+    
+    intf = to_usb_interface(dev);
+    launcher = usb_get_intfdata(intf);
+    
+    return sprintf(buf, "%u\n", launcher->fire_interval);
+}
+
+/**
+* @brief Invoked function if something is stored in "fire_interval-file".
+* The interval must not be shorter than fire_hold, a running sequence keeps its values.
+* @return Returns the number of bytes stored, -EINVAL on invalid input.
+*/
+static ssize_t store_fire_interval(struct device *dev, struct device_attribute *attr,
+			 const char *buf, size_t count){
+			 
+    struct usb_interface* intf;
+    unsigned int interval;
+    unsigned long flags;
+    
+    intf = to_usb_interface(dev);                       
+    launcher = usb_get_intfdata(intf);
+    
+    if (kstrtouint(buf, 10, &interval) || interval == 0){
+        return -EINVAL;
+    }
+    
+    spin_lock_irqsave(&launcher->fire_lock, flags);
+    if (interval < launcher->fire_hold){
+        spin_unlock_irqrestore(&launcher->fire_lock, flags);
+        return -EINVAL;
+    }
+    launcher->fire_interval = interval;
+    spin_unlock_irqrestore(&launcher->fire_lock, flags);
+    
+    return count;
+}
+
+/**
+* @brief Invoked function if the "fire_hold-file" is read
+* @return Returns the time FIRE is latched per shot in milliseconds
+*/
+static ssize_t show_fire_hold(struct device *dev, struct device_attribute *attr, char *buf){
+
+    struct usb_interface *intf;
+    
+    intf = to_usb_interface(dev);
+    launcher = usb_get_intfdata(intf);
+    
+    return sprintf(buf, "%u\n", launcher->fire_hold);
+}
+
+/**
+* @brief Invoked function if something is stored in "fire_hold-file".
+* The hold time must not be longer than fire_interval, a running sequence keeps its values.
+* @return Returns the number of bytes stored, -EINVAL on invalid input.
+*/
+static ssize_t store_fire_hold(struct device *dev, struct device_attribute *attr,
+			 const char *buf, size_t count){
+			 
+    struct usb_interface* intf;
+    unsigned int hold;
+    unsigned long flags;
+    
+    intf = to_usb_interface(dev);                       
+    launcher = usb_get_intfdata(intf);
+    
+    if (kstrtouint(buf, 10, &hold) || hold == 0){
+        return -EINVAL;
+    }
+    
+    spin_lock_irqsave(&launcher->fire_lock, flags);
+    if (hold > launcher->fire_interval){
+        spin_unlock_irqrestore(&launcher->fire_lock, flags);
+        return -EINVAL;
+    }
+    launcher->fire_hold = hold;
+    spin_unlock_irqrestore(&launcher->fire_lock, flags);
+    
+    return count;
+}
+
+/**
+* @brief Invoked function if the "fire_stats-file" is read
+* @return Returns state, shot counts, measured cycle times and the shots per minute
+* of the current or last fire sequence. The rate is the cadence of the measured
+* start-to-start cycles, it needs at least two shots.
+*/
+static ssize_t show_fire_stats(struct device *dev, struct device_attribute *attr, char *buf){
+
+    struct usb_interface *intf;
+    unsigned long flags;
+    const char *state;
+    unsigned int requested, done, elapsed, last, min, max, cycles, total;
+    unsigned int rate = 0;
+    
+    intf = to_usb_interface(dev);
+    launcher = usb_get_intfdata(intf);
+    
+    spin_lock_irqsave(&launcher->fire_lock, flags);
+    if (launcher->fire_running){
+        state = "running";
+    } else if (launcher->fire_result){
+        state = launcher->fire_result;
+    } else {
+        state = "idle";
+    }
+    requested = launcher->fire_requested;
+    done = launcher->fire_done;
+    elapsed = launcher->fire_elapsed;
+    last = launcher->cycle_last;
+    min = launcher->cycle_min;
+    max = launcher->cycle_max;
+    cycles = launcher->cycle_count;
+    total = launcher->cycle_total;
+    spin_unlock_irqrestore(&launcher->fire_lock, flags);
+    
+    /* shots per minute in tenths, from the measured start-to-start cycles */
+    if (total){
+        rate = div_u64((u64)cycles * 600000, total);
+    }
+    
+    return sprintf(buf, "state: %s\nrequested: %u\nfired: %u\nelapsed_ms: %u\n"
+                        "cycle_last_ms: %u\ncycle_min_ms: %u\ncycle_max_ms: %u\n"
+                        "cycle_avg_ms: %u\nshots_per_minute: %u.%u\n",
+                   state, requested, done, elapsed, last, min, max,
+                   cycles ? total / cycles : 0, rate / 10, rate % 10);
+}
+
 /* Helper macros for creating the device attributes */
 static DEVICE_ATTR(left, 0666, show_left, store_left);
 static DEVICE_ATTR(right, 0666, show_right, store_right);
@@ -566,6 +1088,230 @@ static DEVICE_ATTR(up, 0666, show_up, store_up);
 static DEVICE_ATTR(down, 0666, show_down, store_down);
 static DEVICE_ATTR(fire, 0666, show_fire, store_fire);
 static DEVICE_ATTR(stop, 0666, show_stop, store_stop);
+static DEVICE_ATTR(fire_sequence, 0666, show_fire_sequence, store_fire_sequence);
+static DEVICE_ATTR(fire_interval, 0666, show_fire_interval, store_fire_interval);
+static DEVICE_ATTR(fire_hold, 0666, show_fire_hold, store_fire_hold);
+static DEVICE_ATTR(fire_stats, 0444, show_fire_stats, NULL);
+
+/**
+* @brief Work function sending the joystick state to the device.
+* Runs in process context, as usb_control_msg() may sleep. Events arriving
+* while a transfer is in flight are coalesced, only the latest mask is sent.
+* Nothing is sent while a fire sequence runs, launcher_fire_end() reschedules
+* the work when the sequence is over.
+*/
+static void launcher_joy_work(struct work_struct *work){
+
+    struct usb_launcher *dev = container_of(work, struct usb_launcher, joy_work);
+    unsigned char mask;
+    unsigned long flags;
+
+    spin_lock_irqsave(&joy_lock, flags);
+    mask = dev->joy_mask;
+    spin_unlock_irqrestore(&joy_lock, flags);
+
+    mutex_lock(&dev->send_lock);
+
+    if (mask == dev->joy_sent || launcher_fire_busy(dev)){
+        goto out;
+    }
+
+    if (launcher_send(dev, mask) >= 0){
+        dev->joy_sent = mask;
+        dev->left = !!(mask & LEFT);
+        dev->right = !!(mask & RIGHT);
+        dev->up = !!(mask & UP);
+        dev->down = !!(mask & DOWN);
+        dev->fire = !!(mask & FIRE);
+    }
+
+out:
+    mutex_unlock(&dev->send_lock);
+}
+
+/**
+* @brief Maps an axis value to -1, 0 or 1 using the configured deadzone
+*/
+static int launcher_joy_axis(struct input_dev *idev, unsigned int code, int value){
+
+    s64 min = input_abs_get_min(idev, code);
+    s64 max = input_abs_get_max(idev, code);
+    s64 center = min + (max - min) / 2;
+    s64 range = (max - min) / 2;
+
+    if (range <= 0){
+        return 0;
+    }
+    if ((value - center) * 100 > range * joystick_deadzone){
+        return 1;
+    }
+    if ((center - value) * 100 > range * joystick_deadzone){
+        return -1;
+    }
+    return 0;
+}
+
+/**
+* @brief Builds the command mask from the state of all joystick controls.
+* The stick and the d-pad are tracked separately, so releasing one does not cancel
+* the other. If both are deflected on one axis, the d-pad wins. Called with joy_lock held.
+*/
+static unsigned char launcher_joy_mask(void){
+
+    unsigned char mask = STOP;
+    int x = joy_state.x_hat ? joy_state.x_hat : joy_state.x_stick;
+    int y = joy_state.y_hat ? joy_state.y_hat : joy_state.y_stick;
+
+    if (x < 0){
+        mask |= LEFT;
+    } else if (x > 0){
+        mask |= RIGHT;
+    }
+    if (y < 0){
+        mask |= UP;
+    } else if (y > 0){
+        mask |= DOWN;
+    }
+    if (joy_state.trigger || joy_state.a){
+        mask |= FIRE;
+    }
+    return mask;
+}
+
+/**
+* @brief Invoked by the input core for every event of the bound device.
+* Called in atomic context: only the state of the control is updated here. On
+* SYN_REPORT the mask is built and launcher_joy_work() issues the transfer.
+*/
+static void launcher_joy_event(struct input_handle *handle, unsigned int type,
+             unsigned int code, int value){
+
+    unsigned long flags;
+
+    spin_lock_irqsave(&joy_lock, flags);
+
+    switch (type){
+    case EV_ABS:
+        switch (code){
+        case ABS_X:
+            joy_state.x_stick = launcher_joy_axis(handle->dev, code, value);
+            break;
+        case ABS_HAT0X:
+            joy_state.x_hat = launcher_joy_axis(handle->dev, code, value);
+            break;
+        case ABS_Y:
+            joy_state.y_stick = launcher_joy_axis(handle->dev, code, value);
+            break;
+        case ABS_HAT0Y:
+            joy_state.y_hat = launcher_joy_axis(handle->dev, code, value);
+            break;
+        }
+        break;
+    case EV_KEY:
+        if (code == BTN_TRIGGER){
+            joy_state.trigger = !!value;
+        } else if (code == BTN_A){
+            joy_state.a = !!value;
+        }
+        break;
+    case EV_SYN:
+        if (code == SYN_REPORT && joy_launcher != NULL){
+            joy_launcher->joy_mask = launcher_joy_mask();
+            schedule_work(&joy_launcher->joy_work);
+        }
+        break;
+    }
+
+    spin_unlock_irqrestore(&joy_lock, flags);
+}
+
+/**
+* @brief Invoked by the input core for every matching input device.
+* Binds only to the device named by the "joystick" module parameter.
+* @return Returns 0 on success, -ENODEV if the device is not the configured one
+*/
+static int launcher_joy_connect(struct input_handler *handler, struct input_dev *idev,
+             const struct input_device_id *id){
+
+    struct input_handle *handle;
+    int retval;
+
+    if (idev->name == NULL || strcmp(idev->name, joystick) != 0){
+        return -ENODEV;
+    }
+
+    handle = kzalloc(sizeof(struct input_handle), GFP_KERNEL);
+    if (handle == NULL){
+        return -ENOMEM;
+    }
+
+    handle->dev = idev;
+    handle->handler = handler;
+    handle->name = "missilelauncher";
+
+    retval = input_register_handle(handle);
+    if (retval){
+        goto err_free;
+    }
+
+    retval = input_open_device(handle);
+    if (retval){
+        goto err_unregister;
+    }
+
+    pr_info("missile launcher: joystick %s connected\n", idev->name);
+    return 0;
+
+err_unregister:
+    input_unregister_handle(handle);
+err_free:
+    kfree(handle);
+    return retval;
+}
+
+/**
+* @brief Invoked by the input core when the bound input device goes away.
+* Stops all movements, so the launcher does not keep turning.
+*/
+static void launcher_joy_disconnect(struct input_handle *handle){
+
+    unsigned long flags;
+
+    input_close_device(handle);
+    input_unregister_handle(handle);
+    kfree(handle);
+
+    spin_lock_irqsave(&joy_lock, flags);
+    memset(&joy_state, 0, sizeof(joy_state));
+    if (joy_launcher != NULL){
+        joy_launcher->joy_mask = STOP;
+        schedule_work(&joy_launcher->joy_work);
+    }
+    spin_unlock_irqrestore(&joy_lock, flags);
+}
+
+/* input devices the joystick handler is offered: sticks and d-pads */
+static const struct input_device_id joy_ids[] = {
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT | INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { BIT_MASK(ABS_X) },
+	},
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT | INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_HAT0X)] = BIT_MASK(ABS_HAT0X) },
+	},
+	{ },
+};
+
+static struct input_handler launcher_joy_handler = {
+	.event =	launcher_joy_event,
+	.connect =	launcher_joy_connect,
+	.disconnect =	launcher_joy_disconnect,
+	.name =		"missilelauncher",
+	.id_table =	joy_ids,
+};
 
 /**
 * @brief Function called when the USB core has found the USB device.
@@ -587,10 +1333,25 @@ static int launcher_probe(struct usb_interface *interface, const struct usb_devi
 	memset (dev, 0x00, sizeof (*dev));
 
 	dev->udev = usb_get_dev(udev);
+	dev->interface = interface;
+	INIT_WORK(&dev->joy_work, launcher_joy_work);
+	INIT_DELAYED_WORK(&dev->fire_work, launcher_fire_work);
+	spin_lock_init(&dev->fire_lock);
+	mutex_init(&dev->send_lock);
+	dev->fire_interval = FIRE_INTERVAL;
+	dev->fire_hold = FIRE_HOLD;
 	
 	/* save our data pointer in this interface device */
 	usb_set_intfdata (interface, dev);
 	
+	/* the joystick drives the first attached launcher */
+	spin_lock_irq(&joy_lock);
+	list_add_tail(&dev->list, &launchers);
+	if (joy_launcher == NULL){
+	    joy_launcher = dev;
+	}
+	spin_unlock_irq(&joy_lock);
+	
 	
 	if ((ret = device_create_file(&interface->dev, &dev_attr_left)) < 0){
 	    err("Error while file creation. Error number %d", ret);
@@ -610,6 +1371,18 @@ static int launcher_probe(struct usb_interface *interface, const struct usb_devi
 	if ((ret = device_create_file(&interface->dev, &dev_attr_stop)) < 0){
 	    err("Error while file creation. Error number %d", ret);
 	}
+	if ((ret = device_create_file(&interface->dev, &dev_attr_fire_sequence)) < 0){
+	    err("Error while file creation. Error number %d", ret);
+	}
+	if ((ret = device_create_file(&interface->dev, &dev_attr_fire_interval)) < 0){
+	    err("Error while file creation. Error number %d", ret);
+	}
+	if ((ret = device_create_file(&interface->dev, &dev_attr_fire_hold)) < 0){
+	    err("Error while file creation. Error number %d", ret);
+	}
+	if ((ret = device_create_file(&interface->dev, &dev_attr_fire_stats)) < 0){
+	    err("Error while file creation. Error number %d", ret);
+	}
 
 	dev_info(&interface->dev, "USB Launcher device now attached\n");
 	
@@ -632,13 +1405,37 @@ static void launcher_disconnect(struct usb_interface *interface){
 
 	dev = usb_get_intfdata (interface);
 	usb_set_intfdata (interface, NULL);
-
+	
+	/* hand the joystick over to the next launcher, if any */
+	spin_lock_irq(&joy_lock);
+	list_del(&dev->list);
+	if (joy_launcher == dev){
+	    if (list_empty(&launchers)){
+	        joy_launcher = NULL;
+	    } else {
+	        joy_launcher = list_first_entry(&launchers, struct usb_launcher, list);
+	    }
+	}
+	spin_unlock_irq(&joy_lock);
+	
 	device_remove_file(&interface->dev, &dev_attr_left);
 	device_remove_file(&interface->dev, &dev_attr_right);
 	device_remove_file(&interface->dev, &dev_attr_up);
 	device_remove_file(&interface->dev, &dev_attr_down);
 	device_remove_file(&interface->dev, &dev_attr_fire);
     device_remove_file(&interface->dev, &dev_attr_stop);
+	device_remove_file(&interface->dev, &dev_attr_fire_sequence);
+	device_remove_file(&interface->dev, &dev_attr_fire_interval);
+	device_remove_file(&interface->dev, &dev_attr_fire_hold);
+	device_remove_file(&interface->dev, &dev_attr_fire_stats);
+	
+	/* no sequence can be started anymore, end a running one */
+	if (launcher_fire_abort(dev)){
+	    launcher_fire_send(dev, STOP);
+	}
+	
+	/* let a pending transfer run, it may be the STOP queued by launcher_joy_disconnect() */
+	flush_work(&dev->joy_work);
     
     /* Frees the memory of the device */
 	usb_put_dev(dev->udev);
@@ -665,7 +1462,7 @@ static struct usb_driver launcher_driver = {
 
 /**
 * @brief Initialization function called when the module is loaded
-* Registers our usb_driver
+* Registers our usb_driver and, if the "joystick" parameter is set, the joystick input handler
 * @return On success returns the value given by usb_register(), on error the error number
 */
 static int __init launcher_init(void){
@@ -675,6 +1472,16 @@ static int __init launcher_init(void){
 	retval = usb_register(&launcher_driver);
 	if (retval){
 		err("usb_register failed. Error number %d", retval);
+		return retval;
+	}
+	
+	if (joystick != NULL && *joystick != '\0'){
+	    retval = input_register_handler(&launcher_joy_handler);
+	    if (retval){
+	        err("input_register_handler failed. Error number %d", retval);
+	        usb_deregister(&launcher_driver);
+	        return retval;
+	    }
 	}
 	pr_alert("USB Missile Launcher drivers loaded");
     pr_alert("idVendor: 0x0416 idProduct: 0x9391\n");
@@ -684,10 +1491,13 @@ static int __init launcher_init(void){
 
 /**
 * @brief Exit function called when the driver is unloaded.
-* Deregisters the usb_driver
+* Deregisters the joystick input handler and the usb_driver
 */
 static void __exit launcher_exit(void){
 
+    if (joystick != NULL && *joystick != '\0'){
+        input_unregister_handler(&launcher_joy_handler);
+    }
     usb_deregister(&launcher_driver);
 }
 